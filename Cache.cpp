@@ -0,0 +1,436 @@
+#include "Cache.h"
+
+int Cache::calculate_set_index(long long address)
+{
+    return (address >> log_block_size) % num_sets;
+}
+
+long long Cache::calculate_tag(long long address)
+{
+    return address >> (log_block_size + log_num_sets);
+}
+
+long long Cache::calculate_address(long long tag, int set_index) const 
+{
+    return (tag << (log_block_size + log_num_sets)) | (set_index << log_block_size);
+}
+
+int Cache::find_lru_block(int set_index)
+{
+    // first element is LRU block
+    if (!sets[set_index].lru_position.empty())
+    {
+        return sets[set_index].lru_position.front();
+    }
+    else
+    {
+        // when there isn't any blocks
+        return -1; // return invalid index
+    }
+}
+
+// @optimal
+void Cache::set_next_use(map<long long, queue<int>>& accesses)
+{
+    // just a pointer to the map in Simulator to avoid duplicating data
+    next_use_index = &accesses;
+}
+
+unsigned long long Cache::memory_footprint() const
+{
+    unsigned long long bytes = sizeof(Cache) + sets.capacity() * sizeof(CacheSet);
+    for (const CacheSet &set : sets)
+    {
+        bytes += set.lines.capacity() * sizeof(CacheLine);
+        bytes += set.lru_position.capacity() * sizeof(long long);
+        // std::queue -> std::deque: one 512 byte chunk plus its 8 entry map
+        bytes += 512 + 8 * sizeof(void *);
+    }
+    return bytes;
+}
+
+// @optimal, out of core
+void Cache::set_next_use(NextUseFile& next_use)
+{
+    next_use_file = &next_use;
+}
+
+// a line's next use goes stale when the block was accessed without touching this cache
+// (e.g. an L1 hit, seen from L2); follow the chain of next uses until it is in the future
+long long Cache::resolve_next_use(int set_index, int block_index)
+{
+    long long next_use = sets[set_index].lines[block_index].next_use;
+    while (next_use < access_time)
+    {
+        next_use = next_use_file->lookup(next_use);
+    }
+    sets[set_index].lines[block_index].next_use = next_use;
+    return next_use;
+}
+
+bool Cache::evict_block(int set_index, int block_index)
+{
+    bool wasDirty = sets[set_index].lines[block_index].dirty;
+    evicted_address = calculate_address(sets[set_index].lines[block_index].tag, set_index);
+    evicted_next_use = sets[set_index].lines[block_index].next_use;
+    evicted_upper_present = sets[set_index].lines[block_index].upper_present;
+
+    eviction_flag = true; // flag so that the Simulation class knows if an eviction occurred.
+
+    if (wasDirty)
+    {
+        // Increment the write-back counter
+        if (!warming)
+        {
+            writebacks++;
+        }
+        writeback_flag = true;
+    }
+
+    // Reset the block
+    sets[set_index].lines[block_index].tag = -1;
+    sets[set_index].lines[block_index].dirty = false;
+
+    return wasDirty; // returns if the block was dirty or not so that it can be written back to L2
+}
+
+void Cache::update_lru(int set_index, int accessed_index)
+{
+    // Move the accessed block to the most recently used position
+    auto accessed_lru = std::find(sets[set_index].lru_position.begin(), sets[set_index].lru_position.end(), accessed_index);
+    if (accessed_lru != sets[set_index].lru_position.end())
+    {
+        sets[set_index].lru_position.erase(accessed_lru);
+    }
+    sets[set_index].lru_position.push_back(accessed_index);
+}
+
+void Cache::update_fifo(int set_index, int index)
+{
+    // remove first element in queue
+    sets[set_index].fifo_position.pop();
+
+    // Place previous element at the back
+    sets[set_index].fifo_position.push(index);
+}
+
+void Cache::fill_line(int set_index, int block_index, long long tag, char op)
+{
+    CacheLine &line = sets[set_index].lines[block_index];
+    line.tag = tag;
+    line.dirty = (op == 'w');
+    line.next_use = access_next_use;
+    line.upper_present = false;
+    last_line = &line;
+}
+
+bool Cache::allocate_block(int set_index, long long tag, char op)
+{
+    bool foundEmptyLine = false;
+    for (int i = 0; i < assoc; ++i)
+    {
+        if (sets[set_index].lines[i].tag == -1)
+        { // Empty line found
+            fill_line(set_index, i, tag, op);             // Set dirty if it's a write
+            update_lru(set_index, i);                     // Move to the most recently used position
+            sets[set_index].fifo_position.push(i);        // Add index to fifo queue
+            foundEmptyLine = true;
+            break;
+        }
+    }
+
+    if (!foundEmptyLine)
+    {
+        // Find the least recently used (LRU) block if the set is full
+        // while warming, OPTIMAL falls back to LRU: next-use bookkeeping is skipped then
+        if (replacement_policy == 0 || (replacement_policy == 2 && warming))
+        {
+            int lru_index = sets[set_index].lru_position.front();
+
+            // Evict the LRU block
+            evict_block(set_index, lru_index);
+
+            // allocate new block
+            fill_line(set_index, lru_index, tag, op); // Set dirty based on operation
+
+            // Since we just used this block, update its LRU position
+            update_lru(set_index, lru_index);
+        }
+        else if (replacement_policy == 1)
+        {
+            // FIFO
+            // get index of first element in queue
+            int fifo_index = sets[set_index].fifo_position.front();
+
+            // If that line to be replaced is dirty, increment writeback
+            if (sets[set_index].lines[fifo_index].dirty && !warming)
+            {
+                writebacks++;
+            }
+
+            // Perform tag replacement
+            fill_line(set_index, fifo_index, tag, op);
+
+            // Move index from front of queue to the back
+            update_fifo(set_index, fifo_index);
+        }
+        else if (replacement_policy == 2)
+        {
+            // OPTIMAL
+            int optimal_index = -1;
+            int highestFutureUse = -1;
+            long long furthest_next_use = -1;
+            if (next_use_file)
+            {
+                for (unsigned int i = 0; i < assoc; i++)
+                {
+                    // out of core: each line carries its own next use, no per-address lookups
+                    long long next_use_of_block = resolve_next_use(set_index, i);
+                    if (next_use_of_block > furthest_next_use)
+                    {
+                        furthest_next_use = next_use_of_block;
+                        optimal_index = i;
+                    }
+                    if (next_use_of_block == NextUseFile::NEVER)
+                    {
+                        break;
+                    }
+                }
+            }
+            else
+            {
+                for (int i = 0; i < assoc; i++){
+                    long long block_address = calculate_address(sets[set_index].lines[i].tag, set_index);
+
+                    // iterate through all possible addresses maping to this block for their next use
+                    // we only care about the NEXT use
+                    int next_use_of_block = INT_MAX;
+                    for (int j = 0; j < block_size; j++)
+                    {
+                        auto ptr = next_use_index->find(block_address + j);
+                        if (ptr == next_use_index->end()){
+                            continue;
+                        }
+
+                        if (ptr->second.empty()){
+                            continue;
+                        }
+
+                        if (ptr->second.front() < next_use_of_block) {
+                            next_use_of_block = ptr->second.front();
+                        }
+
+                    }
+
+                    if (next_use_of_block == INT_MAX){
+                        optimal_index = i;
+                        break;
+                    }
+
+                    if (next_use_of_block > highestFutureUse){
+                        highestFutureUse = next_use_of_block;
+                        optimal_index = i;
+                    }
+
+                }
+            }
+
+            if (optimal_index == -1)
+            {
+                // problem
+                optimal_index = 0;
+            }
+
+            if (sets[set_index].lines[optimal_index].dirty && !warming)
+            {
+                writebacks++;
+            }
+
+            fill_line(set_index, optimal_index, tag, op); // Set dirty based on operation
+        }
+    }
+    return true;
+}
+
+// for inclusive cache --> check if the block is there and invalidate
+bool Cache::check_and_invalidate(long long address)
+{
+    int set_index = (address >> log_block_size) % num_sets;
+    long long tag = address >> (log_block_size + log_num_sets);
+
+    // iterate through the set to find a matching tag
+    for (int i = 0; i < assoc; i++)
+    {
+        if (sets[set_index].lines[i].tag == tag)
+        {
+            // Block found, invalidate it
+            bool wasDirty = sets[set_index].lines[i].dirty;
+            sets[set_index].lines[i].tag = -1; // invalidate the block
+            sets[set_index].lines[i].dirty = false; // clear the dirty flag
+            
+            // If the block was dirty --> writeback to main memory
+            if (wasDirty && !warming)
+            {
+                inclusive_writeback_counter++;
+            }
+
+            return wasDirty; // return true if the block was dirty 
+        }
+    }
+
+    // Block not found or not dirty, no writeback needed
+    return false;
+}
+
+bool Cache::simulate_access(char op, long long address)
+{
+    writeback_flag = false;
+    eviction_flag = false;
+
+    int set_index = (address >> log_block_size) % num_sets;
+    long long tag = address >> (log_block_size + log_num_sets);
+
+    // Increment reads or writes count based on operation type
+    if (warming)
+    {
+        // tags only, no statistics
+    }
+    else if (op == 'r')
+    {
+        reads_count++;
+    }
+    else if (op == 'w')
+    {
+        writes_count++;
+    }
+
+    // Search for the tag in the set
+    bool hit = false;
+    bool wasDirty = false;
+    for (int i = 0; i < assoc; i++)
+    {
+        if (sets[set_index].lines[i].tag == tag)
+        {
+            // Hit found
+            hit = true;
+            if (!warming)
+            {
+                hit_count++;
+            }
+            sets[set_index].lines[i].next_use = access_next_use;
+            last_line = &sets[set_index].lines[i];
+            if (op == 'w')
+            {
+                sets[set_index].lines[i].dirty = true;
+            }
+            update_lru(set_index, i);
+            break;
+        }
+
+        if (sets[set_index].lines[i].dirty)
+        {
+            wasDirty = true; // Set wasDirty if any block in the set is dirty
+        }
+    }
+
+    if (!hit)
+    {
+        // Miss
+        // Both write misses and read misses will cause block to be allocated in Cache.
+        allocate_block(set_index, tag, op);
+
+        if (warming)
+        {
+            // tags only, no statistics
+        }
+        else if (op == 'r')
+        {
+            read_misses++;
+        }
+        else if (op == 'w')
+        {
+            write_misses++;
+        }
+    }
+
+    if (classifier)
+    {
+        classifier->access(static_cast<unsigned long long>(address) >> log_block_size, hit, !warming);
+    }
+
+    return hit;
+}
+
+void Cache::calculate_memory_traffic()
+{
+    total_memory_traffic = (read_misses + write_misses + writebacks);
+    cout << "m. total memory traffic: " << total_memory_traffic << "\n";
+}
+
+int Cache::calculate_inclusive_memory_traffic()
+{
+    total_memory_traffic = (read_misses + write_misses + writebacks);
+    return total_memory_traffic;
+}
+
+int Cache::return_inclusive_writeback_counter()
+{
+    return inclusive_writeback_counter;
+}
+
+void Cache::L1_print_statistics()
+{
+    // Updated to print additional required statistics
+    unsigned long long accesses = reads_count + writes_count;
+    float miss_rate = accesses > 0 ? static_cast<float>(read_misses + write_misses) / accesses : 0;
+
+    cout << "a. number of L1 reads: " << reads_count << "\n";
+    cout << "b. number of L1 read misses: " << read_misses << "\n";
+    cout << "c. number of L1 writes: " << writes_count << "\n";
+    cout << "d. number of L1 write misses: " << write_misses << "\n";
+    cout << "e. L1 miss rate: " << fixed << setprecision(6) << (accesses > 0 ? miss_rate : 0) << "\n";
+    cout << "f. number of L1 writebacks: " << writebacks << "\n";
+    
+}
+
+void Cache::L2_print_statistics()
+{
+    // Updated to print additional required statistics
+    unsigned long long accesses = reads_count + writes_count;
+    float miss_rate = accesses > 0 ? static_cast<float>(read_misses + write_misses) / accesses : 0;
+
+    cout << "g. number of L2 reads: " << reads_count << "\n";
+    cout << "h. number of L2 read misses: " << read_misses << "\n";
+    cout << "i. number of L2 writes: " << writes_count << "\n";
+    cout << "j. number of L2 write misses: " << write_misses << "\n";
+    cout << "k. L2 miss rate: " << (static_cast<float>(read_misses) / (reads_count)) << "\n";      // this MR calculation is specific to L2.
+    cout << "l. number of L2 writebacks: " << writebacks << "\n";
+}
+
+void Cache::print_miss_classification(const std::string &level)
+{
+    if (!classifier)
+    {
+        return;
+    }
+    cout << level << " compulsory misses: " << classifier->get_compulsory() << "\n";
+    cout << level << " capacity misses: " << classifier->get_capacity() << "\n";
+    cout << level << " conflict misses: " << classifier->get_conflict() << "\n";
+}
+
+void Cache::print_contents(std::ostream &out)
+{
+    //cout << "Final Cache Contents:\n";
+    for (unsigned long long i = 0; i < num_sets; ++i)
+    {
+        out << "Set " << i << ":";
+        for (auto &line : sets[i].lines)
+        {
+            if (line.tag != -1)
+                out << " " << hex << line.tag << (line.dirty ? " D" : "") << "";
+            else
+                out << " [Empty]";
+        }
+        out << dec << "\n"; // Switch back to decimal for non-hex output
+    }
+}
@@ -4,6 +4,7 @@
 #include <vector>
 #include <algorithm>
 #include <queue>
+#include <climits>
 
 // CacheLine class definition
 class CacheLine
@@ -11,7 +12,9 @@ class CacheLine
 public:
     long long tag;
     bool dirty;
-    CacheLine() : tag(-1), dirty(false) {}
+    long long next_use;     // out-of-core OPTIMAL: trace index of the next access to this block
+    bool upper_present;     // inclusive L2: block may also be in L1 (never false while it is)
+    CacheLine() : tag(-1), dirty(false), next_use(LLONG_MAX), upper_present(false) {}
 };
 
 // CacheSet class definition
@@ -0,0 +1,179 @@
+#include "MissClassifier.h"
+
+MissClassifier::MissClassifier(unsigned long long capacity_blocks)
+    : capacity_blocks(capacity_blocks)
+{
+    // room for twice the capacity keeps buckets at most half full, so spills are rare
+    table_bits = 1;
+    while ((1ULL << table_bits) * BUCKET_WAYS < 2 * capacity_blocks)
+    {
+        table_bits++;
+    }
+    bucket_mask = (1ULL << table_bits) - 1;
+    table.assign((1ULL << table_bits) + 1, Bucket());
+    spilled.assign(1ULL << table_bits, 0);
+
+    sentinel = static_cast<uint32_t>((1ULL << table_bits) * BUCKET_WAYS);
+    prev_of(sentinel) = sentinel;
+    next_of(sentinel) = sentinel;
+
+    seen_pages.assign(1ULL << seen_pages_bits, PageSlot{0, 0});
+}
+
+// bitmap of a page of blocks, allocated on first use
+uint32_t MissClassifier::page_base(uint64_t page)
+{
+    uint64_t key = page + 1;
+    uint64_t mask = seen_pages.size() - 1;
+    uint64_t i = slot_of(key, seen_pages_bits);
+    while (seen_pages[i].key != 0)
+    {
+        if (seen_pages[i].key == key)
+        {
+            return seen_pages[i].base;
+        }
+        i = (i + 1) & mask;
+    }
+
+    uint32_t base = static_cast<uint32_t>(seen_bits.size());
+    seen_bits.resize(seen_bits.size() + PAGE_WORDS, 0);
+    seen_pages[i].key = key;
+    seen_pages[i].base = base;
+
+    // grow at 50% load
+    uint64_t pages = seen_bits.size() / PAGE_WORDS;
+    if (pages * 2 > seen_pages.size())
+    {
+        std::vector<PageSlot> old;
+        old.swap(seen_pages);
+        seen_pages_bits++;
+        seen_pages.assign(1ULL << seen_pages_bits, PageSlot{0, 0});
+        mask = seen_pages.size() - 1;
+        for (const PageSlot &slot : old)
+        {
+            if (slot.key == 0)
+            {
+                continue;
+            }
+            uint64_t j = slot_of(slot.key, seen_pages_bits);
+            while (seen_pages[j].key != 0)
+            {
+                j = (j + 1) & mask;
+            }
+            seen_pages[j] = slot;
+        }
+    }
+    return base;
+}
+
+bool MissClassifier::first_touch(uint64_t block)
+{
+    uint64_t page = block >> PAGE_SHIFT;
+    if (page != last_page)
+    {
+        last_page = page;
+        last_page_base = page_base(page);
+    }
+
+    uint64_t bit = block & ((1ULL << PAGE_SHIFT) - 1);
+    uint64_t &word = seen_bits[last_page_base + (bit >> 6)];
+    uint64_t mask = 1ULL << (bit & 63);
+    if (word & mask)
+    {
+        return false;
+    }
+    word |= mask;
+    return true;
+}
+
+// first free way from the key's home bucket on; there always is one, the table is at most half full
+uint32_t MissClassifier::table_insert(uint64_t key)
+{
+    uint64_t b = slot_of(key, table_bits);
+    while (true)
+    {
+        Bucket &bucket = table[b];
+        unsigned free_ways = ways_matching(bucket, 0);
+        if (free_ways != 0)
+        {
+            int w = __builtin_ctz(free_ways);
+            bucket.key[w] = key;
+            return static_cast<uint32_t>(b * BUCKET_WAYS + w);
+        }
+        spilled[b]++;
+        b = (b + 1) & bucket_mask;
+    }
+}
+
+void MissClassifier::table_erase(uint32_t slot)
+{
+    uint64_t b = slot / BUCKET_WAYS;
+    int w = slot % BUCKET_WAYS;
+
+    // take back the spill counts the insert left between the home bucket and this one
+    for (uint64_t h = slot_of(table[b].key[w], table_bits); h != b; h = (h + 1) & bucket_mask)
+    {
+        spilled[h]--;
+    }
+    table[b].key[w] = 0;
+}
+
+void MissClassifier::unlink(uint32_t slot)
+{
+    uint32_t prev = prev_of(slot);
+    uint32_t next = next_of(slot);
+    next_of(prev) = next;
+    prev_of(next) = prev;
+}
+
+void MissClassifier::push_front(uint32_t slot)
+{
+    uint32_t first = next_of(sentinel);
+    prev_of(slot) = sentinel;
+    next_of(slot) = first;
+    prev_of(first) = slot;
+    next_of(sentinel) = slot;
+}
+
+bool MissClassifier::shadow_access(uint64_t key)
+{
+    if (capacity_blocks == 0)
+    {
+        return false;
+    }
+
+    uint64_t b = slot_of(key, table_bits);
+    while (true)
+    {
+        unsigned match = ways_matching(table[b], key);
+        if (match != 0)
+        {
+            uint32_t slot = static_cast<uint32_t>(b * BUCKET_WAYS + __builtin_ctz(match));
+            if (slot != next_of(sentinel))
+            {
+                unlink(slot);
+                push_front(slot);
+            }
+            return true;
+        }
+        if (spilled[b] == 0)
+        {
+            break;
+        }
+        b = (b + 1) & bucket_mask;
+    }
+
+    // miss: make room by dropping the LRU entry
+    if (resident == capacity_blocks)
+    {
+        uint32_t victim = prev_of(sentinel);
+        unlink(victim);
+        table_erase(victim);
+    }
+    else
+    {
+        resident++;
+    }
+    push_front(table_insert(key));
+    return false;
+}
@@ -0,0 +1,122 @@
+#ifndef MISS_CLASSIFIER_H
+#define MISS_CLASSIFIER_H
+
+#include <vector>
+#include <cstdint>
+
+// 3C miss classification (Hill): a miss is
+//   compulsory  if the block was never referenced before,
+//   capacity    if a fully associative LRU cache of the same size would also miss,
+//   conflict    otherwise.
+// The shadow cache is a fixed-size hashed LRU list (O(1) per access), updated on
+// every access the real cache sees. The first-touch set is a bitmap per page of
+// blocks, pages found through an open-addressing table; traces touch blocks in
+// clusters, so it stays small enough to live in the host's caches.
+class MissClassifier
+{
+private:
+    // stored keys are block + 1 / page + 1 so 0 means empty
+    static uint64_t slot_of(uint64_t key, int bits)
+    {
+        return (key * 0x9E3779B97F4A7C15ULL) >> (64 - bits);
+    }
+
+    // first-touch set: one bit per block, 1 << PAGE_SHIFT blocks per page
+    static const int PAGE_SHIFT = 12;
+    static const int PAGE_WORDS = (1 << PAGE_SHIFT) / 64;
+    struct PageSlot
+    {
+        uint64_t key;       // page + 1, 0 = empty
+        uint32_t base;      // first word in seen_bits
+    };
+    std::vector<PageSlot> seen_pages;
+    int seen_pages_bits = 6;
+    std::vector<uint64_t> seen_bits;
+    uint64_t last_page = UINT64_MAX;
+    uint32_t last_page_base = 0;
+
+    // shadow fully associative LRU: a hash table of one-cache-line buckets, whose slots
+    // are also the nodes of the MRU -> LRU list. A lookup reads one line, and the LRU
+    // victim's key sits next to its links. Entries never move: a full bucket spills into
+    // the next one and counts the spill, and lookups only walk on past a bucket while
+    // its spill count is non-zero.
+    static const int BUCKET_WAYS = 4;
+    struct alignas(64) Bucket
+    {
+        uint64_t key[BUCKET_WAYS];      // block + 1, 0 = empty
+        uint32_t prev[BUCKET_WAYS];     // list links, as slot numbers (bucket * BUCKET_WAYS + way)
+        uint32_t next[BUCKET_WAYS];
+    };
+    std::vector<Bucket> table;          // one extra bucket at the end holds the list sentinel
+    std::vector<uint32_t> spilled;      // per bucket: entries that passed it to a later one
+    int table_bits;
+    uint64_t bucket_mask;
+    uint32_t sentinel;
+    unsigned long long capacity_blocks;
+    unsigned long long resident = 0;
+
+    // bit w set when way w holds key; no per-way branches to mispredict
+    static unsigned ways_matching(const Bucket &bucket, uint64_t key)
+    {
+        unsigned match = 0;
+        for (int w = 0; w < BUCKET_WAYS; w++)
+        {
+            match |= (bucket.key[w] == key) << w;
+        }
+        return match;
+    }
+
+    uint32_t &prev_of(uint32_t slot) { return table[slot / BUCKET_WAYS].prev[slot % BUCKET_WAYS]; }
+    uint32_t &next_of(uint32_t slot) { return table[slot / BUCKET_WAYS].next[slot % BUCKET_WAYS]; }
+
+    unsigned long long compulsory = 0;
+    unsigned long long capacity = 0;
+    unsigned long long conflict = 0;
+
+    bool first_touch(uint64_t block);
+    uint32_t page_base(uint64_t page);
+    bool shadow_access(uint64_t key);
+    uint32_t table_insert(uint64_t key);
+    void table_erase(uint32_t slot);
+    void unlink(uint32_t slot);
+    void push_front(uint32_t slot);
+
+public:
+    MissClassifier(unsigned long long capacity_blocks);
+
+    // every access, in order; hit = the real cache hit. count = false only warms the shadow state
+    void access(unsigned long long block, bool hit, bool count)
+    {
+        uint64_t key = block + 1;
+        bool shadow_hit = shadow_access(key);
+        if (hit)
+        {
+            // a hit block was inserted into the first-touch set by the miss that brought it in
+            return;
+        }
+        // a shadow hit means the block was seen before, so the first-touch set is only asked on shadow misses
+        bool first = !shadow_hit && first_touch(block);
+        if (!count)
+        {
+            return;
+        }
+        if (first)
+        {
+            compulsory++;
+        }
+        else if (!shadow_hit)
+        {
+            capacity++;
+        }
+        else
+        {
+            conflict++;
+        }
+    }
+
+    unsigned long long get_compulsory() const { return compulsory; }
+    unsigned long long get_capacity() const { return capacity; }
+    unsigned long long get_conflict() const { return conflict; }
+};
+
+#endif // MISS_CLASSIFIER_H
@@ -0,0 +1,215 @@
+#include "NextUseFile.h"
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+static std::runtime_error io_error(const std::string &what)
+{
+    return std::runtime_error("next-use side file: " + what + ": " + strerror(errno));
+}
+
+// anonymous scratch file in $TMPDIR (or /tmp), unlinked right away so it disappears with the fd
+static int open_scratch_file()
+{
+    const char *dir = getenv("TMPDIR");
+    std::string path = std::string(dir && *dir ? dir : "/tmp") + "/sim_cache_nextuse_XXXXXX";
+    std::vector<char> name(path.begin(), path.end());
+    name.push_back('\0');
+
+    int fd = mkstemp(name.data());
+    if (fd < 0)
+    {
+        throw io_error("cannot create " + path);
+    }
+    unlink(name.data());
+    return fd;
+}
+
+static void pread_all(int fd, void *buf, size_t bytes, off_t offset)
+{
+    char *p = static_cast<char *>(buf);
+    while (bytes > 0)
+    {
+        ssize_t n = pread(fd, p, bytes, offset);
+        if (n <= 0)
+        {
+            throw io_error("read failed");
+        }
+        p += n;
+        bytes -= n;
+        offset += n;
+    }
+}
+
+static void write_all(int fd, const void *buf, size_t bytes)
+{
+    const char *p = static_cast<const char *>(buf);
+    while (bytes > 0)
+    {
+        ssize_t n = write(fd, p, bytes);
+        if (n <= 0)
+        {
+            throw io_error("write failed");
+        }
+        p += n;
+        bytes -= n;
+    }
+}
+
+NextUseFile::NextUseFile(unsigned long long window)
+{
+    // windows start on page boundaries, so round up to a whole number of pages
+    unsigned long long per_page = sysconf(_SC_PAGESIZE) / sizeof(long long);
+    if (window < per_page)
+    {
+        window = per_page;
+    }
+    this->window = (window + per_page - 1) / per_page * per_page;
+}
+
+NextUseFile::~NextUseFile()
+{
+    unmap_window();
+    if (side_fd >= 0)
+    {
+        close(side_fd);
+    }
+}
+
+void NextUseFile::build(TraceSource &source, unsigned int block_size)
+{
+    int log_block_size = static_cast<int>(log2(block_size));
+    int blocks_fd = open_scratch_file();
+
+    try
+    {
+        // forward pass: block number of every access -> scratch file
+        std::vector<long long> chunk;
+        chunk.reserve(window);
+        std::vector<TraceAccess> batch(4096);
+        size_t batch_size;
+        length = 0;
+        while ((batch_size = source.read_batch(batch.data(), batch.size())) > 0)
+        {
+            for (size_t b = 0; b < batch_size; b++)
+            {
+                chunk.push_back(batch[b].address >> log_block_size);
+                if (chunk.size() == window)
+                {
+                    write_all(blocks_fd, chunk.data(), chunk.size() * sizeof(long long));
+                    chunk.clear();
+                }
+            }
+            length += batch_size;
+        }
+        write_all(blocks_fd, chunk.data(), chunk.size() * sizeof(long long));
+
+        if (side_fd < 0)
+        {
+            side_fd = open_scratch_file();
+        }
+        if (ftruncate(side_fd, static_cast<off_t>(length * sizeof(long long))) != 0)
+        {
+            throw io_error("cannot size side file");
+        }
+
+        // backward pass, one chunk at a time from the end of the trace
+        std::unordered_map<long long, long long> next_seen;
+        unsigned long long chunks = (length + window - 1) / window;
+        for (unsigned long long c = chunks; c-- > 0;)
+        {
+            unsigned long long start = c * window;
+            unsigned long long count = std::min(window, length - start);
+
+            chunk.resize(count);
+            pread_all(blocks_fd, chunk.data(), count * sizeof(long long), static_cast<off_t>(start * sizeof(long long)));
+
+            void *region = mmap(nullptr, count * sizeof(long long), PROT_READ | PROT_WRITE, MAP_SHARED, side_fd,
+                                static_cast<off_t>(start * sizeof(long long)));
+            if (region == MAP_FAILED)
+            {
+                throw io_error("cannot map side file");
+            }
+            long long *out = static_cast<long long *>(region);
+
+            for (unsigned long long i = count; i-- > 0;)
+            {
+                auto seen = next_seen.find(chunk[i]);
+                if (seen == next_seen.end())
+                {
+                    out[i] = NEVER;
+                    next_seen.emplace(chunk[i], start + i);
+                }
+                else
+                {
+                    out[i] = seen->second;
+                    seen->second = start + i;
+                }
+            }
+            munmap(region, count * sizeof(long long));
+        }
+    }
+    catch (...)
+    {
+        close(blocks_fd);
+        throw;
+    }
+
+    close(blocks_fd);
+    unmap_window();
+    position = 0;
+}
+
+void NextUseFile::map_window(unsigned long long start)
+{
+    if (start >= length)
+    {
+        throw std::runtime_error("next-use side file: read past the end of the trace");
+    }
+    unmap_window();
+
+    // keep windows aligned to `window` so the offset is page aligned
+    mapped_start = start / window * window;
+    mapped_length = std::min(window, length - mapped_start);
+    void *region = mmap(nullptr, mapped_length * sizeof(long long), PROT_READ, MAP_SHARED, side_fd,
+                        static_cast<off_t>(mapped_start * sizeof(long long)));
+    if (region == MAP_FAILED)
+    {
+        mapped_length = 0;
+        throw io_error("cannot map side file");
+    }
+    madvise(region, mapped_length * sizeof(long long), MADV_SEQUENTIAL);
+    mapped = static_cast<const long long *>(region);
+}
+
+void NextUseFile::unmap_window()
+{
+    if (mapped)
+    {
+        munmap(const_cast<long long *>(mapped), mapped_length * sizeof(long long));
+    }
+    mapped = nullptr;
+    mapped_start = 0;
+    mapped_length = 0;
+}
+
+long long NextUseFile::lookup(unsigned long long index) const
+{
+    if (index >= mapped_start && index < mapped_start + mapped_length)
+    {
+        return mapped[index - mapped_start];
+    }
+
+    long long value;
+    pread_all(side_fd, &value, sizeof(value), static_cast<off_t>(index * sizeof(long long)));
+    return value;
+}
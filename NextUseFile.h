@@ -0,0 +1,65 @@
+#ifndef NEXT_USE_FILE_H
+#define NEXT_USE_FILE_H
+
+#include "TraceSource.h"
+#include <climits>
+#include <cstddef>
+
+// @optimal, out of core
+// For every access i of the trace, the index of the next access to the same block
+// (NEVER if there is none), kept in a memory-mapped side file instead of RAM.
+//
+// build() makes two passes in chunks of `window` accesses: a forward pass that spills
+// the block number of each access to a scratch file, then a backward pass over the
+// chunks (last to first) that fills the side file. The simulation then streams the
+// side file forward with next(), one window mapped at a time, so memory use depends
+// on the window (plus one entry per distinct block in the backward pass), not on the
+// length of the trace.
+class NextUseFile
+{
+private:
+    unsigned long long window;      // entries per chunk / mapped window
+    int side_fd = -1;
+    unsigned long long length = 0;
+
+    // forward streaming state
+    const long long *mapped = nullptr;
+    unsigned long long mapped_start = 0;
+    unsigned long long mapped_length = 0;
+    unsigned long long position = 0;
+
+    void map_window(unsigned long long start);
+    void unmap_window();
+
+public:
+    static const long long NEVER = LLONG_MAX;
+
+    NextUseFile(unsigned long long window);
+    ~NextUseFile();
+
+    NextUseFile(const NextUseFile &) = delete;
+    NextUseFile &operator=(const NextUseFile &) = delete;
+
+    // scans source once (it is not rewound here); throws std::runtime_error on I/O errors
+    void build(TraceSource &source, unsigned int block_size);
+
+    // next-use index of the next access in trace order
+    long long next()
+    {
+        if (position >= mapped_start + mapped_length)
+        {
+            map_window(position);
+        }
+        return mapped[position++ - mapped_start];
+    }
+
+    // next-use index of access `index`, in any order (used to walk forward from a stale next use)
+    long long lookup(unsigned long long index) const;
+
+    void rewind() { position = 0; }
+
+    unsigned long long size() const { return length; }
+    unsigned long long window_bytes() const { return window * sizeof(long long); }
+};
+
+#endif // NEXT_USE_FILE_H
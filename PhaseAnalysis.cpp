@@ -0,0 +1,172 @@
+#include "PhaseAnalysis.h"
+#include <cmath>
+#include <algorithm>
+#include <limits>
+
+PhaseAnalysis::PhaseAnalysis(unsigned long long interval_length, unsigned int block_size)
+    : interval_length(interval_length), log_block_size(static_cast<int>(log2(block_size))), current(SIGNATURE_DIM, 0.0f)
+{
+}
+
+void PhaseAnalysis::close_interval()
+{
+    // normalize so a short last interval compares fairly with the full ones
+    for (int d = 0; d < SIGNATURE_DIM; d++)
+    {
+        signatures.push_back(current[d] / current_length);
+        current[d] = 0.0f;
+    }
+    lengths.push_back(current_length);
+    current_length = 0;
+}
+
+void PhaseAnalysis::finish()
+{
+    if (current_length > 0)
+    {
+        close_interval();
+    }
+}
+
+float PhaseAnalysis::distance(const float *a, const float *b) const
+{
+    float sum = 0.0f;
+    for (int d = 0; d < SIGNATURE_DIM; d++)
+    {
+        float diff = a[d] - b[d];
+        sum += diff * diff;
+    }
+    return sum;
+}
+
+void PhaseAnalysis::cluster(unsigned int k)
+{
+    size_t n = num_intervals();
+    points.clear();
+    selected.assign(n, false);
+    if (n == 0 || k == 0)
+    {
+        return;
+    }
+    if (k > n)
+    {
+        k = static_cast<unsigned int>(n);
+    }
+
+    // deterministic farthest-point seeding, starting from the first interval
+    std::vector<float> centroids(signatures.begin(), signatures.begin() + SIGNATURE_DIM);
+    std::vector<float> nearest(n, std::numeric_limits<float>::max());
+    for (unsigned int c = 1; c < k; c++)
+    {
+        const float *last = &centroids[(c - 1) * SIGNATURE_DIM];
+        size_t farthest = 0;
+        for (size_t i = 0; i < n; i++)
+        {
+            float dist = distance(&signatures[i * SIGNATURE_DIM], last);
+            if (dist < nearest[i])
+            {
+                nearest[i] = dist;
+            }
+            if (nearest[i] > nearest[farthest])
+            {
+                farthest = i;
+            }
+        }
+        centroids.insert(centroids.end(), signatures.begin() + farthest * SIGNATURE_DIM, signatures.begin() + (farthest + 1) * SIGNATURE_DIM);
+    }
+
+    // Lloyd iterations
+    std::vector<unsigned int> assignment(n, 0);
+    for (int iteration = 0; iteration < 100; iteration++)
+    {
+        bool changed = false;
+        for (size_t i = 0; i < n; i++)
+        {
+            unsigned int best = 0;
+            float best_dist = std::numeric_limits<float>::max();
+            for (unsigned int c = 0; c < k; c++)
+            {
+                float dist = distance(&signatures[i * SIGNATURE_DIM], &centroids[c * SIGNATURE_DIM]);
+                if (dist < best_dist)
+                {
+                    best_dist = dist;
+                    best = c;
+                }
+            }
+            if (iteration == 0 || assignment[i] != best)
+            {
+                changed = true;
+                assignment[i] = best;
+            }
+        }
+        if (!changed)
+        {
+            break;
+        }
+
+        std::vector<float> sums(k * SIGNATURE_DIM, 0.0f);
+        std::vector<size_t> sizes(k, 0);
+        for (size_t i = 0; i < n; i++)
+        {
+            sizes[assignment[i]]++;
+            for (int d = 0; d < SIGNATURE_DIM; d++)
+            {
+                sums[assignment[i] * SIGNATURE_DIM + d] += signatures[i * SIGNATURE_DIM + d];
+            }
+        }
+        for (unsigned int c = 0; c < k; c++)
+        {
+            // an empty cluster keeps its old centroid
+            if (sizes[c] == 0)
+            {
+                continue;
+            }
+            for (int d = 0; d < SIGNATURE_DIM; d++)
+            {
+                centroids[c * SIGNATURE_DIM + d] = sums[c * SIGNATURE_DIM + d] / sizes[c];
+            }
+        }
+    }
+
+    // the interval closest to each centroid represents the cluster
+    unsigned long long total_accesses = 0;
+    for (size_t i = 0; i < n; i++)
+    {
+        total_accesses += lengths[i];
+    }
+    for (unsigned int c = 0; c < k; c++)
+    {
+        size_t representative = n;
+        float best_dist = std::numeric_limits<float>::max();
+        unsigned long long cluster_accesses = 0;
+        size_t cluster_intervals = 0;
+        for (size_t i = 0; i < n; i++)
+        {
+            if (assignment[i] != c)
+            {
+                continue;
+            }
+            cluster_accesses += lengths[i];
+            cluster_intervals++;
+            float dist = distance(&signatures[i * SIGNATURE_DIM], &centroids[c * SIGNATURE_DIM]);
+            if (dist < best_dist)
+            {
+                best_dist = dist;
+                representative = i;
+            }
+        }
+        if (representative == n)
+        {
+            continue;
+        }
+
+        SimPoint p;
+        p.interval = representative;
+        p.weight = static_cast<double>(cluster_accesses) / total_accesses;
+        p.cluster_intervals = cluster_intervals;
+        points.push_back(p);
+        selected[representative] = true;
+    }
+
+    std::sort(points.begin(), points.end(), [](const SimPoint &a, const SimPoint &b) { return a.interval < b.interval; });
+}
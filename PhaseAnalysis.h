@@ -0,0 +1,64 @@
+#ifndef PHASE_ANALYSIS_H
+#define PHASE_ANALYSIS_H
+
+#include <vector>
+#include <cstddef>
+
+// one representative interval and the share of the trace it stands for
+struct SimPoint
+{
+    size_t interval;
+    double weight;              // accesses in its cluster / all accesses
+    size_t cluster_intervals;
+};
+
+// SimPoint-style phase analysis without basic blocks: each interval of the trace gets a
+// signature (histogram of block addresses, hashed into SIGNATURE_DIM buckets), the
+// signatures are clustered with k-means, and the interval closest to each centroid is
+// picked to represent its cluster.
+class PhaseAnalysis
+{
+private:
+    unsigned long long interval_length;
+    int log_block_size;
+
+    std::vector<float> signatures;              // SIGNATURE_DIM floats per interval
+    std::vector<unsigned long long> lengths;    // accesses per interval (the last may be short)
+    std::vector<float> current;
+    unsigned long long current_length = 0;
+
+    std::vector<SimPoint> points;
+    std::vector<bool> selected;
+
+    void close_interval();
+    float distance(const float *a, const float *b) const;
+
+public:
+    static const int SIGNATURE_BITS = 5;
+    static const int SIGNATURE_DIM = 1 << SIGNATURE_BITS;
+
+    PhaseAnalysis(unsigned long long interval_length, unsigned int block_size);
+
+    // feed every address of the trace in order
+    void add(long long address)
+    {
+        unsigned long long block = static_cast<unsigned long long>(address) >> log_block_size;
+        current[(block * 0x9E3779B97F4A7C15ULL) >> (64 - SIGNATURE_BITS)] += 1.0f;
+        if (++current_length == interval_length)
+        {
+            close_interval();
+        }
+    }
+
+    // closes a trailing partial interval, call once after the last add()
+    void finish();
+
+    // k-means over the interval signatures, fills simpoints()
+    void cluster(unsigned int k);
+
+    size_t num_intervals() const { return lengths.size(); }
+    const std::vector<SimPoint> &simpoints() const { return points; }
+    bool is_simpoint(size_t interval) const { return interval < selected.size() && selected[interval]; }
+};
+
+#endif // PHASE_ANALYSIS_H
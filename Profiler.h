@@ -0,0 +1,258 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <chrono>
+#include <string>
+#include <vector>
+#include <iostream>
+#include <iomanip>
+#include <cstring>
+#include <cstdint>
+#include <sys/resource.h>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#define PROFILER_HAS_PERF 1
+#else
+#define PROFILER_HAS_PERF 0
+#endif
+
+// Optional hardware counters (cycles, LLC misses, branch misses).
+// If perf_event_open isn't available or is denied (perf_event_paranoid, containers, ...)
+// the counters just stay closed and every read returns 0.
+class HardwareCounters
+{
+private:
+    static const int NUM_COUNTERS = 3;
+    int fds[NUM_COUNTERS];
+    bool available = false;
+
+#if PROFILER_HAS_PERF
+    static int open_counter(uint32_t type, uint64_t config)
+    {
+        struct perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = type;
+        attr.config = config;
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        return static_cast<int>(syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0));
+    }
+#endif
+
+public:
+    HardwareCounters()
+    {
+        for (int i = 0; i < NUM_COUNTERS; i++)
+        {
+            fds[i] = -1;
+        }
+    }
+
+    ~HardwareCounters()
+    {
+        close_all();
+    }
+
+    HardwareCounters(const HardwareCounters &) = delete;
+    HardwareCounters &operator=(const HardwareCounters &) = delete;
+
+    bool open()
+    {
+#if PROFILER_HAS_PERF
+        fds[0] = open_counter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES);
+        fds[1] = open_counter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+        fds[2] = open_counter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES);
+
+        available = true;
+        for (int i = 0; i < NUM_COUNTERS; i++)
+        {
+            if (fds[i] < 0)
+            {
+                available = false;
+            }
+        }
+
+        if (!available)
+        {
+            close_all();
+            return false;
+        }
+
+        for (int i = 0; i < NUM_COUNTERS; i++)
+        {
+            ioctl(fds[i], PERF_EVENT_IOC_RESET, 0);
+            ioctl(fds[i], PERF_EVENT_IOC_ENABLE, 0);
+        }
+#endif
+        return available;
+    }
+
+    void close_all()
+    {
+#if PROFILER_HAS_PERF
+        for (int i = 0; i < NUM_COUNTERS; i++)
+        {
+            if (fds[i] >= 0)
+            {
+                close(fds[i]);
+            }
+            fds[i] = -1;
+        }
+#endif
+        available = false;
+    }
+
+    bool is_available() const { return available; }
+
+    // reads running totals for cycles, LLC misses and branch misses (in that order)
+    void read(uint64_t out[NUM_COUNTERS]) const
+    {
+        for (int i = 0; i < NUM_COUNTERS; i++)
+        {
+            out[i] = 0;
+#if PROFILER_HAS_PERF
+            if (available)
+            {
+                uint64_t value = 0;
+                if (::read(fds[i], &value, sizeof(value)) == sizeof(value))
+                {
+                    out[i] = value;
+                }
+            }
+#endif
+        }
+    }
+};
+
+// Collects wall time (monotonic clock) and hardware counter deltas per named phase.
+// Phases are sequential: begin_phase() closes whichever phase was open.
+class Profiler
+{
+private:
+    typedef std::chrono::steady_clock clock;
+
+    struct Phase
+    {
+        std::string name;
+        double seconds = 0.0;
+        uint64_t cycles = 0;
+        uint64_t llc_misses = 0;
+        uint64_t branch_misses = 0;
+    };
+
+    bool enabled = false;
+    bool in_phase = false;
+    std::vector<Phase> phases;
+    clock::time_point phase_start;
+    uint64_t counters_start[3] = {0, 0, 0};
+    HardwareCounters hw;
+
+public:
+    void enable()
+    {
+        enabled = true;
+        hw.open();
+    }
+
+    bool is_enabled() const { return enabled; }
+
+    void begin_phase(const std::string &name)
+    {
+        if (!enabled)
+        {
+            return;
+        }
+        end_phase();
+
+        Phase p;
+        p.name = name;
+        phases.push_back(p);
+        in_phase = true;
+        hw.read(counters_start);
+        phase_start = clock::now();
+    }
+
+    void end_phase()
+    {
+        if (!enabled || !in_phase)
+        {
+            return;
+        }
+
+        clock::time_point now = clock::now();
+        uint64_t counters_end[3];
+        hw.read(counters_end);
+
+        Phase &p = phases.back();
+        p.seconds = std::chrono::duration<double>(now - phase_start).count();
+        p.cycles = counters_end[0] - counters_start[0];
+        p.llc_misses = counters_end[1] - counters_start[1];
+        p.branch_misses = counters_end[2] - counters_start[2];
+        in_phase = false;
+    }
+
+    double phase_seconds(const std::string &name) const
+    {
+        for (const Phase &p : phases)
+        {
+            if (p.name == name)
+            {
+                return p.seconds;
+            }
+        }
+        return 0.0;
+    }
+
+    // peak resident set size of this process in bytes
+    static long long peak_rss_bytes()
+    {
+        struct rusage usage;
+        if (getrusage(RUSAGE_SELF, &usage) != 0)
+        {
+            return 0;
+        }
+#ifdef __APPLE__
+        return usage.ru_maxrss;          // bytes on macOS
+#else
+        return usage.ru_maxrss * 1024LL; // kilobytes on Linux
+#endif
+    }
+
+    void print_phases(std::ostream &out) const
+    {
+        double total = 0.0;
+        for (const Phase &p : phases)
+        {
+            total += p.seconds;
+        }
+
+        out << std::fixed << std::setprecision(6);
+        for (const Phase &p : phases)
+        {
+            out << "  " << std::left << std::setw(20) << p.name << std::right
+                << std::setw(12) << p.seconds << " s"
+                << std::setw(8) << std::setprecision(1) << (total > 0 ? 100.0 * p.seconds / total : 0.0) << " %";
+            if (hw.is_available())
+            {
+                out << "  cycles: " << p.cycles
+                    << "  LLC misses: " << p.llc_misses
+                    << "  branch misses: " << p.branch_misses;
+            }
+            out << std::setprecision(6) << "\n";
+        }
+        out << "  " << std::left << std::setw(20) << "total" << std::right << std::setw(12) << total << " s\n";
+        if (!hw.is_available())
+        {
+            out << "  (hardware counters unavailable)\n";
+        }
+        out << std::defaultfloat;
+    }
+};
+
+#endif // PROFILER_H
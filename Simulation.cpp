@@ -0,0 +1,606 @@
+#include "Simulation.h"
+#include <climits>
+#include <stdexcept>
+
+// approximate bytes held by the OPTIMAL next-use map (rb-tree nodes + per-key deques)
+unsigned long long Simulation::accesses_map_footprint() const
+{
+    // libstdc++ rb-tree node header is 4 words
+    const unsigned long long node_bytes = 4 * sizeof(void *) + sizeof(pair<const long long, queue<int>>);
+    const unsigned long long chunk_bytes = 512;
+    const unsigned long long ints_per_chunk = chunk_bytes / sizeof(int);
+
+    unsigned long long bytes = sizeof(accesses);
+    for (const auto &entry : accesses)
+    {
+        unsigned long long chunks = entry.second.size() / ints_per_chunk + 1;
+        bytes += node_bytes + chunks * chunk_bytes + 8 * sizeof(void *);
+    }
+    return bytes;
+}
+
+void Simulation::print_profile()
+{
+    if (!profiler.is_enabled())
+    {
+        return;
+    }
+
+    double sim_seconds = profiler.phase_seconds("simulation");
+    unsigned long long cache_bytes = L1_cache.memory_footprint() + (isL2Enabled ? L2_cache.memory_footprint() : 0);
+
+    // goes to stderr so the stdout report stays byte-identical to the validation runs
+    std::cerr << "===== Profile =====\n";
+    profiler.print_phases(std::cerr);
+    std::cerr << "accesses: " << total_accesses << "\n";
+    std::cerr << "accesses/sec (simulation): " << std::fixed << std::setprecision(0)
+              << (sim_seconds > 0 ? total_accesses / sim_seconds : 0.0) << std::defaultfloat << "\n";
+    std::cerr << "peak RSS: " << Profiler::peak_rss_bytes() / 1024 << " KB\n";
+    std::cerr << "accesses map: " << accesses.size() << " keys, ~" << accesses_map_footprint() / 1024 << " KB\n";
+    if (isL2Enabled && inclusionPolicy == 1)
+    {
+        std::cerr << "back-invalidation L1 probes: " << snoop_probes << " (skipped by snoop filter: " << snoop_filtered << ")\n";
+    }
+    if (next_use_file)
+    {
+        std::cerr << "next-use side file: " << next_use_file->size() << " entries, "
+                  << next_use_file->window_bytes() / 1024 << " KB window\n";
+    }
+    std::cerr << "cache state: ~" << cache_bytes / 1024 << " KB\n";
+}
+
+void Simulation::run() 
+{
+    profiler.begin_phase("configuration");
+
+    if (!print_configuration())
+    {
+        return;
+    }
+
+    if (!trace_source)
+    {
+        FileTraceSource *file_source = new FileTraceSource(trace_file);
+        trace_source.reset(file_source);
+        if (!file_source->is_open())
+        {
+            std::cout << "trace_file: " << trace_source->name() << "\n";
+            std::cerr << "Error opening trace file\n";
+            return;
+        }
+    }
+
+    std::cout << "trace_file: " << trace_source->name() << "\n";
+
+    if (simpoint_clusters > 0 && interval_length > 0)
+    {
+        profiler.begin_phase("phase analysis");
+        analyze_phases(*trace_source);
+        trace_source->rewind();
+    }
+
+    //////////// OPTIMAL PRE-PROCESSING ////////////////
+    // only OPTIMAL reads the next-use map, LRU/FIFO skip the extra pass over the trace
+    if (replacement_policy == 2)
+    {
+        profiler.begin_phase("optimal pre-process");
+        if (optimal_window > 0)
+        {
+            next_use_file.reset(new NextUseFile(optimal_window));
+            next_use_file->build(*trace_source, L1_cache.getBlockSize());
+            L1_cache.set_next_use(*next_use_file);
+            if (isL2Enabled)
+            {
+                L2_cache.set_next_use(*next_use_file);
+            }
+        }
+        else
+        {
+            build_next_use(*trace_source);
+        }
+        trace_source->rewind();
+    }
+    //////////////// END OF OPTIMAL PRE-PROCESSING /////////////////////////
+
+    profiler.begin_phase("simulation");
+
+    std::vector<TraceAccess> batch(TRACE_BATCH);
+    size_t batch_size;
+    while ((batch_size = trace_source->read_batch(batch.data(), batch.size())) > 0)
+    {
+        simulate_batch(batch.data(), batch_size);
+    }
+    if (interval_position > 0)
+    {
+        end_interval();     // trailing partial interval
+    }
+
+    profiler.begin_phase("print_contents");
+    print_contents(cout);
+
+    profiler.begin_phase("statistics");
+    print_statistics();
+    print_intervals();
+    print_simpoint_estimate();
+
+    cout.flush();
+    profiler.end_phase();
+    print_profile();
+}
+
+bool Simulation::print_configuration()
+{
+    std::cout << "===== Simulator configuration =====\n";
+    std::cout << "BLOCKSIZE: " << L1_cache.getBlockSize() << "\n";
+    std::cout << "L1_SIZE: " << L1_cache.getNumSets() * L1_cache.getAssoc() * L1_cache.getBlockSize() << "\n";
+    std::cout << "L1_ASSOC: " << L1_cache.getAssoc() << "\n";
+
+    if (isL2Enabled)
+    {
+        std::cout << "L2_SIZE: " << L2_cache.getNumSets() * L2_cache.getAssoc() * L2_cache.getBlockSize() << "\n";
+        std::cout << "L2_ASSOC: " << L2_cache.getAssoc() << "\n";
+    }
+    else
+    {
+        std::cout << "L2_SIZE: " << 0 << "\n";
+        std::cout << "L2_ASSOC: " << 0 << "\n";
+    }
+
+    // Print appropriate replacement policy
+    if (replacement_policy == 0)
+    {
+        std::cout << "REPLACEMENT POLICY: LRU\n";
+    }
+    else if (replacement_policy == 1)
+    {
+        std::cout << "REPLACEMENT POLICY: FIFO\n";
+    }
+    else if (replacement_policy == 2)
+    {
+        std::cout << "REPLACEMENT POLICY: OPTIMAL\n";
+    }
+    else
+    {
+        std::cerr << "Invalid replacement policy\n";
+        return false;
+    }
+
+    std::cout << "INCLUSION PROPERTY: " << (inclusionPolicy == 0 ? "non-inclusive" : "inclusive") << "\n";
+
+    return true;
+}
+
+// @optimal
+// one pass over the whole trace, recording every index at which each address is used
+void Simulation::build_next_use(TraceSource &source)
+{
+    std::vector<TraceAccess> batch(TRACE_BATCH);
+    size_t batch_size;
+
+    long long address;
+    long long previous = -1;
+    int count = 0;
+
+    accesses.clear();
+    current_line = 0;
+    while ((batch_size = source.read_batch(batch.data(), batch.size())) > 0)
+    {
+        for (size_t b = 0; b < batch_size; b++)
+        {
+            address = batch[b].address;
+            if (count == INT_MAX)
+            {
+                throw std::length_error("in-memory OPTIMAL supports at most " + std::to_string(INT_MAX) + " accesses, use --optimal-window=N");
+            }
+
+            // @optimal
+            // setup map of next usages
+            if (previous != address) {
+                //add previous
+                map<long long, queue<int>>::iterator elem = accesses.find(previous);
+                // check if elem was found
+                if (elem != accesses.end()) {
+                    elem->second.push(count - 1);
+                } else {
+                    queue<int> v({count - 1});
+                    accesses.emplace(previous, v);
+                }
+            }
+
+            count++;
+            previous = address;
+        }
+    }
+
+    // need to insert the last item
+    map<long long, queue<int>>::iterator elem = accesses.find(previous);
+    // check if elem was found
+    if(elem != accesses.end())
+    {
+        elem->second.push(count-1);
+    }
+    else
+    {
+        queue<int> v({count-1});
+        accesses.emplace(previous, v);
+    }
+
+
+    L1_cache.set_next_use(accesses);
+    if (isL2Enabled)
+    {
+        L2_cache.set_next_use(accesses);
+    }
+}
+
+void Simulation::simulate_batch(const TraceAccess *batch, size_t n)
+{
+    char op;
+    long long address;
+
+    for (size_t b = 0; b < n; b++)
+    {
+        op = batch[b].op;
+        address = batch[b].address;
+        total_accesses++;
+
+        if (interval_length > 0 && interval_position == 0)
+        {
+            begin_interval();
+        }
+
+        // @optimal, out of core: the next use of this access rides along with the trace
+        long long next_use = 0;
+        long long now = static_cast<long long>(total_accesses - 1);
+        if (next_use_file)
+        {
+            next_use = next_use_file->next();
+            L1_cache.set_access_next_use(now, next_use);
+            L2_cache.set_access_next_use(now, next_use);
+        }
+
+        if(inclusionPolicy == 0)    // for non-inclusive cache
+        {
+            bool hitInL1 = L1_cache.simulate_access(op, address); // returns hit (true) or miss (false)
+
+            if ((L1_cache.writeback_flag) && isL2Enabled)
+            {
+                // L2 writes: equal to the number of dirty blocks evicted from L1 that need to be written back to L2 or main memory.
+                if (next_use_file)
+                {
+                    L2_cache.set_access_next_use(now, L1_cache.evicted_next_use);
+                }
+                bool isL2_writeback_hit = L2_cache.simulate_access('w', L1_cache.evicted_address);
+            }
+
+            if (!hitInL1 && isL2Enabled) // if miss in L1 and L2 is enabled
+            {
+                if (next_use_file)
+                {
+                    L2_cache.set_access_next_use(now, next_use);
+                }
+                bool hitInL2 = L2_cache.simulate_access('r', address); // read L2 cache and attempt to find address
+            }
+
+            // @optimal
+            if (replacement_policy == 2 && !fast_forward && !next_use_file)
+            {
+                // an address the pre-processing pass never saw has no next uses to drop
+                auto uses = accesses.find(address);
+                if (uses != accesses.end() && !uses->second.empty() && uses->second.front() <= current_line)
+                {
+                    uses->second.pop();
+                }
+
+            }
+            current_line++;
+
+        }
+        else if(inclusionPolicy == 1) // for inclusive cache
+        {
+            bool hitInL1 = L1_cache.simulate_access(op, address); // Returns hit (true) or miss (false)
+
+            if ((L1_cache.writeback_flag) && isL2Enabled)
+            {
+                // L2 writebacks: equal to the number of dirty blocks evicted from L1 that need to be written back to L2 or main memory.
+                if (next_use_file)
+                {
+                    L2_cache.set_access_next_use(now, L1_cache.evicted_next_use);
+                }
+                bool isL2_writeback_hit = L2_cache.simulate_access('w', L1_cache.evicted_address);
+                L2_cache.mark_upper_present(false);     // the block just left L1
+                // In case of a miss in L2, we must handle it according to the inclusive policy, including potential evictions.
+                if (!isL2_writeback_hit)
+                {
+                    // If evicting a block from L2, invalidate the corresponding block in L1 if it exists
+                    // The check_and_invalidate method should return true if the evicted block was dirty --> signals a direct WB to main mem.
+                    // Blocks L1 never held (upper-present bit clear) are skipped without probing L1.
+                    if(L2_cache.eviction_flag && !L2_cache.evicted_upper_present)
+                    {
+                        snoop_filtered++;
+                    }
+                    else if(L2_cache.eviction_flag)
+                    {
+                        snoop_probes++;
+                        bool L1_dirty_block_needs_writeback = L1_cache.check_and_invalidate(L2_cache.evicted_address);
+                        if(L1_dirty_block_needs_writeback)
+                        {
+                            // this would be a direct writeback to main mem.
+                        }
+                    }
+                }
+            }
+
+            if (!hitInL1 && isL2Enabled) // If miss in L1 and L2 is enabled
+            {
+                if (next_use_file)
+                {
+                    L2_cache.set_access_next_use(now, next_use);
+                }
+                bool hitInL2 = L2_cache.simulate_access('r', address); // Read L2 cache and attempt to find address
+                L2_cache.mark_upper_present(true);      // L1 is filling this block
+                if (!hitInL2)
+                {
+                    // Upon a miss in L2, when allocating a new block in L2, make sure to also check L1 for inclusivity
+                    // If a block is evicted from L2, check if it exists in L1 and invalidate it
+                    if(L2_cache.eviction_flag && !L2_cache.evicted_upper_present)
+                    {
+                        snoop_filtered++;
+                    }
+                    else if(L2_cache.eviction_flag)
+                    {
+                        snoop_probes++;
+                        bool L1_dirty_block_needs_writeback = L1_cache.check_and_invalidate(L2_cache.evicted_address);
+                        if(L1_dirty_block_needs_writeback)
+                        {
+                            // If the invalidated block in L1 was dirty, handle direct writeback to main memory here.
+                        }
+                    }
+                }
+            }
+        }
+
+        if (interval_length > 0 && ++interval_position == interval_length)
+        {
+            end_interval();
+        }
+    }
+}
+
+void Simulation::print_contents(std::ostream &out)
+{
+    out << "===== L1 contents =====\n";
+    L1_cache.print_contents(out);
+
+    if (isL2Enabled) 
+    {
+        out << "===== L2 contents =====\n";
+        L2_cache.print_contents(out);
+    }
+}
+
+void Simulation::print_statistics()
+{
+    cout << "\n===== Simulation results (raw) =====\n";
+    L1_cache.L1_print_statistics();    // L1 stats
+
+    if (isL2Enabled) 
+    {
+        L2_cache.L2_print_statistics();    // L2 stats
+    }
+    else
+    {
+        // Print zero values for L2 statistics when L2 is not enabled
+        cout << "g. number of L2 reads: 0\n";
+        cout << "h. number of L2 read misses: 0\n";
+        cout << "i. number of L2 writes: 0\n";
+        cout << "j. number of L2 write misses: 0\n";
+        cout << "l. number of L2 writebacks: 0\n";
+        cout << "k. L2 miss rate: 0\n";
+    }
+
+    //////////// MEMORY TRAFFIC CALCULATION ////////////
+    if(inclusionPolicy == 0 && isL2Enabled)
+    {
+        // non-inclusive, L2 enabled
+        L2_cache.calculate_memory_traffic();
+    }
+    else if(inclusionPolicy == 1 && isL2Enabled)
+    {
+        // inclusive, L2 enabled
+        total_memory_traffic = (L2_cache.calculate_inclusive_memory_traffic() + L1_cache.return_inclusive_writeback_counter());
+        cout << "m. total memory traffic: " << total_memory_traffic << "\n";
+    }
+    else if(inclusionPolicy == 0 && (!isL2Enabled))
+    {
+        L1_cache.calculate_memory_traffic();
+    }
+    else if(inclusionPolicy == 1 && (!isL2Enabled))
+    {
+        L1_cache.calculate_memory_traffic();
+    }
+    //////////////////////////////////////////////////////
+
+    if (classify_misses)
+    {
+        cout << "\n===== Miss classification (3C) =====\n";
+        L1_cache.print_miss_classification("L1");
+        if (isL2Enabled)
+        {
+            L2_cache.print_miss_classification("L2");
+        }
+    }
+}
+
+void Simulation::enable_miss_classification()
+{
+    classify_misses = true;
+    L1_cache.enable_miss_classification();
+    if (isL2Enabled)
+    {
+        L2_cache.enable_miss_classification();
+    }
+}
+
+// same rules as the "m. total memory traffic" line, without printing
+unsigned long long Simulation::memory_traffic() const
+{
+    if (!isL2Enabled)
+    {
+        return L1_cache.get_read_misses() + L1_cache.get_write_misses() + L1_cache.get_writebacks();
+    }
+
+    unsigned long long traffic = L2_cache.get_read_misses() + L2_cache.get_write_misses() + L2_cache.get_writebacks();
+    if (inclusionPolicy == 1)
+    {
+        traffic += L1_cache.get_inclusive_writebacks();
+    }
+    return traffic;
+}
+
+IntervalStats Simulation::cumulative_stats() const
+{
+    IntervalStats stats;
+    stats.accesses = L1_cache.get_reads() + L1_cache.get_writes();
+    stats.L1_misses = L1_cache.get_read_misses() + L1_cache.get_write_misses();
+    if (isL2Enabled)
+    {
+        stats.L2_reads = L2_cache.get_reads();
+        stats.L2_read_misses = L2_cache.get_read_misses();
+    }
+    return stats;
+}
+
+void Simulation::begin_interval()
+{
+    // with --simpoints only the chosen intervals are simulated in detail
+    set_fast_forward(phase_analysis && !phase_analysis->is_simpoint(interval_index));
+    interval_start = cumulative_stats();
+}
+
+void Simulation::end_interval()
+{
+    if (!fast_forward)
+    {
+        IntervalStats now = cumulative_stats();
+        IntervalStats delta;
+        delta.interval = interval_index;
+        delta.accesses = now.accesses - interval_start.accesses;
+        delta.L1_misses = now.L1_misses - interval_start.L1_misses;
+        delta.L2_reads = now.L2_reads - interval_start.L2_reads;
+        delta.L2_read_misses = now.L2_read_misses - interval_start.L2_read_misses;
+        intervals.push_back(delta);
+    }
+
+    interval_index++;
+    interval_position = 0;
+}
+
+void Simulation::set_fast_forward(bool on)
+{
+    if (on == fast_forward)
+    {
+        return;
+    }
+    if (!on && replacement_policy == 2)
+    {
+        resync_next_use();
+    }
+
+    fast_forward = on;
+    L1_cache.set_warming(on);
+    L2_cache.set_warming(on);
+}
+
+// @optimal
+// next uses were not popped while fast-forwarding; drop the ones that are now in the past
+void Simulation::resync_next_use()
+{
+    for (auto &entry : accesses)
+    {
+        while (!entry.second.empty() && entry.second.front() < current_line)
+        {
+            entry.second.pop();
+        }
+    }
+}
+
+// one cheap pass over the trace (no cache simulation) to pick the representative intervals
+void Simulation::analyze_phases(TraceSource &source)
+{
+    phase_analysis.reset(new PhaseAnalysis(interval_length, L1_cache.getBlockSize()));
+
+    std::vector<TraceAccess> batch(TRACE_BATCH);
+    size_t batch_size;
+    while ((batch_size = source.read_batch(batch.data(), batch.size())) > 0)
+    {
+        for (size_t b = 0; b < batch_size; b++)
+        {
+            phase_analysis->add(batch[b].address);
+        }
+    }
+    phase_analysis->finish();
+    phase_analysis->cluster(simpoint_clusters);
+}
+
+void Simulation::print_intervals()
+{
+    if (interval_length == 0)
+    {
+        return;
+    }
+
+    cout << "\n===== Interval statistics (every " << interval_length << " accesses) =====\n";
+    cout << "interval accesses L1_misses L1_miss_rate L2_reads L2_read_misses L2_miss_rate\n";
+    for (const IntervalStats &i : intervals)
+    {
+        cout << i.interval << " " << i.accesses << " " << i.L1_misses << " "
+             << fixed << setprecision(6) << (i.accesses > 0 ? static_cast<double>(i.L1_misses) / i.accesses : 0.0) << " "
+             << i.L2_reads << " " << i.L2_read_misses << " "
+             << (i.L2_reads > 0 ? static_cast<double>(i.L2_read_misses) / i.L2_reads : 0.0) << "\n";
+    }
+}
+
+void Simulation::print_simpoint_estimate()
+{
+    if (!phase_analysis)
+    {
+        return;
+    }
+
+    // weighted sum of per-access rates of each representative interval
+    double L1_misses = 0.0;
+    double L2_reads = 0.0;
+    double L2_read_misses = 0.0;
+    unsigned long long detailed_accesses = 0;
+    for (const SimPoint &p : phase_analysis->simpoints())
+    {
+        for (const IntervalStats &i : intervals)
+        {
+            if (i.interval != p.interval || i.accesses == 0)
+            {
+                continue;
+            }
+            L1_misses += p.weight * i.L1_misses / i.accesses;
+            L2_reads += p.weight * i.L2_reads / i.accesses;
+            L2_read_misses += p.weight * i.L2_read_misses / i.accesses;
+            detailed_accesses += i.accesses;
+        }
+    }
+
+    cout << "\n===== SimPoint estimate =====\n";
+    cout << "intervals: " << phase_analysis->num_intervals() << ", simpoints: " << phase_analysis->simpoints().size() << "\n";
+    cout << "detailed accesses: " << detailed_accesses << " of " << total_accesses
+         << " (" << fixed << setprecision(2) << (total_accesses > 0 ? 100.0 * detailed_accesses / total_accesses : 0.0) << "%)\n";
+    cout << "(raw results above cover the detailed intervals only)\n";
+    for (const SimPoint &p : phase_analysis->simpoints())
+    {
+        cout << "simpoint " << p.interval << ": weight " << setprecision(6) << p.weight
+             << " (" << p.cluster_intervals << " intervals)\n";
+    }
+    cout << "estimated L1 miss rate: " << setprecision(6) << L1_misses << "\n";
+    if (isL2Enabled)
+    {
+        cout << "estimated L2 miss rate: " << (L2_reads > 0 ? L2_read_misses / L2_reads : 0.0) << "\n";
+    }
+}
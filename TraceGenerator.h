@@ -0,0 +1,303 @@
+#ifndef TRACE_GENERATOR_H
+#define TRACE_GENERATOR_H
+
+#include "TraceSource.h"
+#include <string>
+#include <vector>
+#include <random>
+#include <cmath>
+#include <cstdint>
+#include <sstream>
+#include <stdexcept>
+
+// Synthetic access patterns, generated on the fly so huge runs need no trace file.
+//
+// Selected with a TRACE_FILE argument of the form
+//     gen:<pattern>[,key=value...]
+// e.g. gen:zipf,count=1000000000,footprint=67108864,alpha=0.9,writes=0.25,seed=7
+//
+// patterns:  seq     word-by-word sweep over the footprint
+//            stride  one access every <stride> bytes, wrapping around the footprint
+//            uniform uniformly random word inside the footprint
+//            zipf    Zipfian choice of <stride>-sized items (skew = alpha, 0 < alpha < 1)
+//            chase   pointer chasing through a random cycle of <stride>-sized nodes
+//            mixed   each access picks one of the patterns above at random
+// keys:      count (accesses, default 1000000), seed (default 1), footprint (bytes, default 1 MiB),
+//            stride (bytes, default 64), alpha (default 0.99), writes (write ratio, default 0.3),
+//            base (hex start address, default 10000000)
+struct GeneratorConfig
+{
+    std::string pattern = "uniform";
+    unsigned long long count = 1000000;
+    unsigned long long seed = 1;
+    unsigned long long footprint = 1 << 20;
+    unsigned long long stride = 64;
+    double alpha = 0.99;
+    double write_ratio = 0.3;
+    long long base = 0x10000000;
+};
+
+class SyntheticTraceSource : public TraceSource
+{
+private:
+    static const int WORD = 4;
+
+    enum Pattern
+    {
+        SEQ,
+        STRIDE,
+        UNIFORM,
+        ZIPF,
+        CHASE,
+        MIXED
+    };
+
+    GeneratorConfig config;
+    std::string spec;
+    Pattern pattern;
+    std::mt19937_64 rng;
+    unsigned long long produced = 0;
+
+    unsigned long long num_words;
+    unsigned long long num_items;   // <stride>-sized items for zipf / chase
+
+    // pattern state
+    unsigned long long seq_offset = 0;
+    unsigned long long stride_offset = 0;
+    unsigned long long chase_node = 0;
+    std::vector<uint32_t> chase_next;
+
+    // zipf constants (Gray et al., "Quickly generating billion-record synthetic databases")
+    double zipf_zetan = 0;
+    double zipf_eta = 0;
+    double zipf_alpha = 0;
+    double zipf_half_pow = 0;
+
+    double next_uniform()
+    {
+        return (rng() >> 11) * (1.0 / 9007199254740992.0);
+    }
+
+    unsigned long long next_zipf_item()
+    {
+        double u = next_uniform();
+        double uz = u * zipf_zetan;
+        unsigned long long rank;
+        if (uz < 1.0)
+        {
+            rank = 0;
+        }
+        else if (uz < 1.0 + zipf_half_pow)
+        {
+            rank = 1;
+        }
+        else
+        {
+            rank = static_cast<unsigned long long>(num_items * std::pow(zipf_eta * u - zipf_eta + 1.0, zipf_alpha));
+        }
+        if (rank >= num_items)
+        {
+            rank = num_items - 1;
+        }
+        // scatter the hot items so they don't all land in neighbouring sets
+        return (rank * 2654435761ULL) % num_items;
+    }
+
+    long long next_address(Pattern p)
+    {
+        unsigned long long offset = 0;
+        switch (p)
+        {
+        case SEQ:
+            offset = seq_offset;
+            seq_offset = (seq_offset + WORD) % config.footprint;
+            break;
+        case STRIDE:
+            offset = stride_offset;
+            stride_offset = (stride_offset + config.stride) % config.footprint;
+            break;
+        case UNIFORM:
+            offset = (rng() % num_words) * WORD;
+            break;
+        case ZIPF:
+            offset = next_zipf_item() * config.stride;
+            break;
+        case CHASE:
+            offset = chase_node * config.stride;
+            chase_node = chase_next[chase_node];
+            break;
+        case MIXED:
+            offset = next_address(static_cast<Pattern>(rng() % MIXED)) - config.base;
+            break;
+        }
+        return config.base + static_cast<long long>(offset);
+    }
+
+    void reset_state()
+    {
+        rng.seed(config.seed);
+        produced = 0;
+        seq_offset = 0;
+        stride_offset = 0;
+        chase_node = 0;
+    }
+
+    void setup_zipf()
+    {
+        if (!(config.alpha > 0.0 && config.alpha < 1.0))
+        {
+            throw std::invalid_argument("zipf alpha must be between 0 and 1");
+        }
+        double theta = config.alpha;
+        zipf_zetan = 0;
+        for (unsigned long long i = 1; i <= num_items; i++)
+        {
+            zipf_zetan += 1.0 / std::pow(static_cast<double>(i), theta);
+        }
+        double zeta2 = 1.0 + 1.0 / std::pow(2.0, theta);
+        zipf_alpha = 1.0 / (1.0 - theta);
+        zipf_eta = (1.0 - std::pow(2.0 / num_items, 1.0 - theta)) / (1.0 - zeta2 / zipf_zetan);
+        zipf_half_pow = std::pow(0.5, theta);
+    }
+
+    void setup_chase()
+    {
+        if (num_items > UINT32_MAX)
+        {
+            throw std::invalid_argument("chase footprint has too many nodes");
+        }
+        // Sattolo's algorithm: a random permutation that is a single cycle over all nodes
+        std::vector<uint32_t> order(num_items);
+        for (unsigned long long i = 0; i < num_items; i++)
+        {
+            order[i] = static_cast<uint32_t>(i);
+        }
+        std::mt19937_64 shuffle_rng(config.seed ^ 0x9e3779b97f4a7c15ULL);
+        for (unsigned long long i = num_items - 1; i > 0; i--)
+        {
+            unsigned long long j = shuffle_rng() % i;
+            std::swap(order[i], order[j]);
+        }
+        chase_next.assign(num_items, 0);
+        for (unsigned long long i = 0; i < num_items; i++)
+        {
+            chase_next[order[i]] = order[(i + 1) % num_items];
+        }
+    }
+
+public:
+    SyntheticTraceSource(const GeneratorConfig &cfg, const std::string &spec) : config(cfg), spec(spec)
+    {
+        if (config.pattern == "seq")
+            pattern = SEQ;
+        else if (config.pattern == "stride")
+            pattern = STRIDE;
+        else if (config.pattern == "uniform")
+            pattern = UNIFORM;
+        else if (config.pattern == "zipf")
+            pattern = ZIPF;
+        else if (config.pattern == "chase")
+            pattern = CHASE;
+        else if (config.pattern == "mixed")
+            pattern = MIXED;
+        else
+            throw std::invalid_argument("unknown generator pattern: " + config.pattern);
+
+        if (config.stride == 0 || config.footprint < config.stride || config.footprint < WORD)
+        {
+            throw std::invalid_argument("generator footprint must be at least one stride");
+        }
+        if (config.write_ratio < 0.0 || config.write_ratio > 1.0)
+        {
+            throw std::invalid_argument("generator write ratio must be between 0 and 1");
+        }
+
+        num_words = config.footprint / WORD;
+        num_items = config.footprint / config.stride;
+
+        if (pattern == ZIPF || pattern == MIXED)
+        {
+            setup_zipf();
+        }
+        if (pattern == CHASE || pattern == MIXED)
+        {
+            setup_chase();
+        }
+        reset_state();
+    }
+
+    size_t read_batch(TraceAccess *out, size_t max) override
+    {
+        size_t n = 0;
+        while (n < max && produced < config.count)
+        {
+            out[n].address = next_address(pattern);
+            out[n].op = next_uniform() < config.write_ratio ? 'w' : 'r';
+            n++;
+            produced++;
+        }
+        return n;
+    }
+
+    bool rewind() override
+    {
+        reset_state();
+        return true;
+    }
+
+    std::string name() const override
+    {
+        return spec;
+    }
+};
+
+// "gen:<pattern>[,key=value...]" -> GeneratorConfig, throws std::invalid_argument on bad specs
+inline GeneratorConfig parse_generator_spec(const std::string &spec)
+{
+    GeneratorConfig cfg;
+    std::stringstream ss(spec.substr(4));
+    std::string field;
+    bool first = true;
+    while (std::getline(ss, field, ','))
+    {
+        if (first)
+        {
+            cfg.pattern = field;
+            first = false;
+            continue;
+        }
+
+        size_t eq = field.find('=');
+        if (eq == std::string::npos)
+        {
+            throw std::invalid_argument("bad generator option: " + field);
+        }
+        std::string key = field.substr(0, eq);
+        std::string value = field.substr(eq + 1);
+
+        if (key == "count")
+            cfg.count = std::stoull(value);
+        else if (key == "seed")
+            cfg.seed = std::stoull(value);
+        else if (key == "footprint")
+            cfg.footprint = std::stoull(value);
+        else if (key == "stride")
+            cfg.stride = std::stoull(value);
+        else if (key == "alpha")
+            cfg.alpha = std::stod(value);
+        else if (key == "writes")
+            cfg.write_ratio = std::stod(value);
+        else if (key == "base")
+            cfg.base = std::stoll(value, nullptr, 16);
+        else
+            throw std::invalid_argument("unknown generator option: " + key);
+    }
+    return cfg;
+}
+
+inline bool is_generator_spec(const std::string &trace_file)
+{
+    return trace_file.compare(0, 4, "gen:") == 0;
+}
+
+#endif // TRACE_GENERATOR_H
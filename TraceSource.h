@@ -0,0 +1,106 @@
+#ifndef TRACE_SOURCE_H
+#define TRACE_SOURCE_H
+
+#include <string>
+#include <fstream>
+#include <iostream>
+#include <cstddef>
+#include <algorithm>
+
+// one memory reference: op is 'r' or 'w'
+struct TraceAccess
+{
+    char op;
+    long long address;
+};
+
+// Where Simulation gets its accesses from. Sources hand out accesses in batches and
+// must be able to rewind, because the OPTIMAL pre-processing makes a pass of its own.
+class TraceSource
+{
+public:
+    virtual ~TraceSource() {}
+
+    // fills up to max entries of out, returns how many were written (0 = end of trace)
+    virtual size_t read_batch(TraceAccess *out, size_t max) = 0;
+
+    // back to the first access; the same sequence must be produced again
+    virtual bool rewind() = 0;
+
+    // what gets printed on the "trace_file:" line
+    virtual std::string name() const = 0;
+};
+
+// text trace in the traces/ format, one "<r|w> <hex address>" per line
+class FileTraceSource : public TraceSource
+{
+private:
+    std::string trace_file;
+    std::ifstream inp;
+
+public:
+    FileTraceSource(const std::string &trace_file) : trace_file(trace_file), inp(trace_file) {}
+
+    bool is_open() const { return inp.is_open(); }
+
+    size_t read_batch(TraceAccess *out, size_t max) override
+    {
+        size_t n = 0;
+        char op;
+        long long address;
+        while (n < max && inp >> op >> std::hex >> address)
+        {
+            out[n].op = op;
+            out[n].address = address;
+            n++;
+        }
+        return n;
+    }
+
+    bool rewind() override
+    {
+        inp.close();
+        inp.clear();
+        inp.open(trace_file);
+        return inp.is_open();
+    }
+
+    std::string name() const override
+    {
+        // Remove "traces/" from the start of the trace file name
+        return trace_file.substr(7);
+    }
+};
+
+// accesses already in memory; the caller keeps ownership of the array
+class ArrayTraceSource : public TraceSource
+{
+private:
+    const TraceAccess *data;
+    size_t length;
+    size_t position = 0;
+
+public:
+    ArrayTraceSource(const TraceAccess *data, size_t length) : data(data), length(length) {}
+
+    size_t read_batch(TraceAccess *out, size_t max) override
+    {
+        size_t n = std::min(max, length - position);
+        std::copy(data + position, data + position + n, out);
+        position += n;
+        return n;
+    }
+
+    bool rewind() override
+    {
+        position = 0;
+        return true;
+    }
+
+    std::string name() const override
+    {
+        return "(in-memory)";
+    }
+};
+
+#endif // TRACE_SOURCE_H
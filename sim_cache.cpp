@@ -1,27 +1,107 @@
 #include "Simulation.h"
+#include "TraceGenerator.h"
 #include <iostream>
 #include <cstdlib>
+#include <memory>
+#include <string>
+#include <vector>
+#include <stdexcept>
 
 int main(int argc, char *argv[])
 {
-    if (argc != 9)
+    // split optional --flags from the positional arguments
+    std::vector<std::string> args;
+    bool profile = false;
+    bool classify = false;
+    std::string interval;
+    std::string simpoints;
+    std::string optimal_window;
+    for (int i = 1; i < argc; i++)
     {
-        std::cerr << "Usage: " << argv[0] << " <BLOCKSIZE> <L1_SIZE> <L1_ASSOC> <L2_SIZE> <L2_ASSOC> <REPLACEMENT_POLICY> <INCLUSION_POLICY> <TRACE_FILE>\n";
+        std::string arg = argv[i];
+        if (arg == "--profile")
+        {
+            profile = true;
+        }
+        else if (arg == "--3c")
+        {
+            classify = true;
+        }
+        else if (arg.compare(0, 11, "--interval=") == 0)
+        {
+            interval = arg.substr(11);
+        }
+        else if (arg.compare(0, 12, "--simpoints=") == 0)
+        {
+            simpoints = arg.substr(12);
+        }
+        else if (arg.compare(0, 17, "--optimal-window=") == 0)
+        {
+            optimal_window = arg.substr(17);
+        }
+        else
+        {
+            args.push_back(arg);
+        }
+    }
+
+    if (args.size() != 8)
+    {
+        std::cerr << "Usage: " << argv[0] << " [--profile] [--interval=N [--simpoints=K]] [--optimal-window=N] [--3c] <BLOCKSIZE> <L1_SIZE> <L1_ASSOC> <L2_SIZE> <L2_ASSOC> <REPLACEMENT_POLICY> <INCLUSION_POLICY> <TRACE_FILE>\n";
         return 1;
     }
 
     try
     {
-        unsigned int block_size = std::stoi(argv[1]);
-        unsigned int L1_size = std::stoi(argv[2]);
-        unsigned int L1_assoc = std::stoi(argv[3]);
-        unsigned int L2_size = std::stoi(argv[4]);
-        unsigned int L2_assoc = std::stoi(argv[5]);
-        unsigned int replacement_policy = std::stoi(argv[6]);
-        unsigned int inclusion_policy = std::stoi(argv[7]);
-        std::string trace_file = argv[8];
+        unsigned int block_size = std::stoi(args[0]);
+        unsigned int L1_size = std::stoi(args[1]);
+        unsigned int L1_assoc = std::stoi(args[2]);
+        unsigned int L2_size = std::stoi(args[3]);
+        unsigned int L2_assoc = std::stoi(args[4]);
+        unsigned int replacement_policy = std::stoi(args[5]);
+        unsigned int inclusion_policy = std::stoi(args[6]);
+        std::string trace_file = args[7];
+
+        // a bad gen: spec fails here, before the configuration header is printed
+        std::unique_ptr<TraceSource> generator;
+        if (is_generator_spec(trace_file))
+        {
+            generator.reset(new SyntheticTraceSource(parse_generator_spec(trace_file), trace_file));
+        }
 
         Simulation sim(block_size, L1_size, L1_assoc, L2_size, L2_assoc, replacement_policy, inclusion_policy, trace_file);
+        if (generator)
+        {
+            sim.set_trace_source(std::move(generator));
+        }
+        if (profile)
+        {
+            sim.enable_profiling();
+        }
+        if (!interval.empty())
+        {
+            sim.enable_interval_stats(std::stoull(interval));
+        }
+        if (!simpoints.empty())
+        {
+            if (interval.empty())
+            {
+                throw std::invalid_argument("--simpoints needs --interval");
+            }
+            sim.enable_simpoints(std::stoul(simpoints));
+        }
+        if (!optimal_window.empty())
+        {
+            sim.enable_out_of_core_optimal(std::stoull(optimal_window));
+            if (replacement_policy == 2 && inclusion_policy == 1)
+            {
+                std::cerr << "note: inclusive OPTIMAL with --optimal-window does not match the in-memory results\n";
+            }
+        }
+        if (classify)
+        {
+            sim.enable_miss_classification();
+        }
         sim.run();
     }
     catch (const std::exception &e)
@@ -42,4 +122,24 @@ int main(int argc, char *argv[])
 5. .\sim_cache 16 1024 1 8192 4 0 0 traces/go_trace.txt         PASS
 6. .\sim_cache 16 1024 2 8192 4 0 1 traces/gcc_trace.txt        PASS
 7. .\sim_cache 16 1024 1 8192 4 0 1 traces/compress_trace.txt   PASS
+
+--profile prints per-phase wall time, accesses/sec, peak RSS and memory estimates to stderr:
+   .\sim_cache --profile 16 1024 2 8192 4 2 0 traces/gcc_trace.txt
+
+TRACE_FILE may also be a synthetic generator spec (see TraceGenerator.h), no trace file needed:
+   .\sim_cache --profile 32 32768 8 1048576 16 0 1 gen:zipf,count=1000000000,footprint=67108864,alpha=0.9
+
+--interval=N adds a miss-rate time series (one line per N accesses) after the raw results.
+--simpoints=K clusters the intervals into K phases, simulates one representative interval per phase
+in detail, only warms the caches through the others, and prints the weighted miss-rate estimate:
+   .\sim_cache --interval=10000 --simpoints=4 16 1024 2 8192 4 0 0 traces/gcc_trace.txt
+
+--optimal-window=N runs OPTIMAL from a next-use side file in $TMPDIR instead of the in-memory map,
+touching N accesses of it at a time (8 bytes per access on disk). Non-inclusive results are identical
+to the in-memory map; inclusive ones are not, because the map path never drops past next uses in
+inclusive mode while the side file always tracks the true next use:
+   .\sim_cache --optimal-window=1048576 16 1024 2 8192 4 2 0 gen:zipf,count=1000000000,footprint=67108864
+
+--3c splits every level's misses into compulsory / capacity / conflict (shadow fully associative LRU):
+   .\sim_cache --3c 16 1024 2 8192 4 0 0 traces/gcc_trace.txt
 */
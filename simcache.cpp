@@ -0,0 +1,226 @@
+#include "simcache.h"
+#include "Simulation.h"
+#include <climits>
+#include <cstddef>
+#include <new>
+#include <sstream>
+
+// simcache_access arrays are handed to Simulation as TraceAccess without copying
+static_assert(sizeof(simcache_access) == sizeof(TraceAccess), "simcache_access must match TraceAccess");
+static_assert(offsetof(simcache_access, op) == offsetof(TraceAccess, op), "simcache_access must match TraceAccess");
+static_assert(offsetof(simcache_access, address) == offsetof(TraceAccess, address), "simcache_access must match TraceAccess");
+
+struct simcache
+{
+    Simulation sim;
+    bool optimal_ready = false;
+    size_t prepared = 0;    // OPTIMAL: accesses whose next uses are known
+    size_t fed = 0;
+
+    simcache(const simcache_config &c)
+        : sim(c.block_size, c.l1_size, c.l1_assoc, c.l2_size, c.l2_assoc, c.replacement_policy, c.inclusion_policy, "") {}
+};
+
+static bool is_power_of_two(unsigned long long x)
+{
+    return x != 0 && (x & (x - 1)) == 0;
+}
+
+// a level is usable when size / (block_size * assoc) is a whole, power-of-two number of sets
+static bool valid_level(uint32_t size, uint32_t assoc, uint32_t block_size)
+{
+    if (assoc == 0 || size == 0)
+    {
+        return false;
+    }
+    unsigned long long set_bytes = static_cast<unsigned long long>(block_size) * assoc;
+    return size % set_bytes == 0 && is_power_of_two(size / set_bytes);
+}
+
+static bool valid_config(const simcache_config &c)
+{
+    if (!is_power_of_two(c.block_size) || !valid_level(c.l1_size, c.l1_assoc, c.block_size))
+    {
+        return false;
+    }
+    bool l2_disabled = c.l2_size == 0 && c.l2_assoc == 0;
+    if (!l2_disabled && !valid_level(c.l2_size, c.l2_assoc, c.block_size))
+    {
+        return false;
+    }
+    return c.replacement_policy <= SIMCACHE_OPTIMAL && c.inclusion_policy <= SIMCACHE_INCLUSIVE;
+}
+
+extern "C" {
+
+int simcache_api_version(void)
+{
+    return SIMCACHE_API_VERSION;
+}
+
+simcache_status simcache_create(const simcache_config *config, simcache_t **out)
+{
+    if (!config || !out)
+    {
+        return SIMCACHE_ERR_ARGUMENT;
+    }
+    *out = NULL;
+    if (!valid_config(*config))
+    {
+        return SIMCACHE_ERR_ARGUMENT;
+    }
+
+    try
+    {
+        *out = new simcache(*config);
+    }
+    catch (const std::bad_alloc &)
+    {
+        return SIMCACHE_ERR_MEMORY;
+    }
+    catch (...)
+    {
+        return SIMCACHE_ERR_INTERNAL;
+    }
+    return SIMCACHE_OK;
+}
+
+void simcache_destroy(simcache_t *sim)
+{
+    delete sim;
+}
+
+simcache_status simcache_prepare_optimal(simcache_t *sim, const simcache_access *trace, size_t count)
+{
+    if (!sim || (!trace && count > 0))
+    {
+        return SIMCACHE_ERR_ARGUMENT;
+    }
+    if (sim->sim.getReplacementPolicy() != SIMCACHE_OPTIMAL)
+    {
+        return SIMCACHE_ERR_STATE;
+    }
+    // next uses are indexed from the first access fed; they cannot be replaced mid-stream
+    if (sim->fed > 0)
+    {
+        return SIMCACHE_ERR_STATE;
+    }
+    // the in-memory next-use map is int-indexed
+    if (count > static_cast<size_t>(INT_MAX))
+    {
+        return SIMCACHE_ERR_ARGUMENT;
+    }
+
+    try
+    {
+        ArrayTraceSource source(reinterpret_cast<const TraceAccess *>(trace), count);
+        sim->sim.build_next_use(source);
+        sim->optimal_ready = true;
+        sim->prepared = count;
+    }
+    catch (const std::bad_alloc &)
+    {
+        return SIMCACHE_ERR_MEMORY;
+    }
+    catch (...)
+    {
+        return SIMCACHE_ERR_INTERNAL;
+    }
+    return SIMCACHE_OK;
+}
+
+simcache_status simcache_feed(simcache_t *sim, const simcache_access *accesses, size_t count)
+{
+    if (!sim || (!accesses && count > 0))
+    {
+        return SIMCACHE_ERR_ARGUMENT;
+    }
+    if (sim->sim.getReplacementPolicy() == SIMCACHE_OPTIMAL)
+    {
+        // past the prepared trace there are no next uses to evict by
+        if (!sim->optimal_ready || count > sim->prepared - sim->fed)
+        {
+            return SIMCACHE_ERR_STATE;
+        }
+    }
+
+    try
+    {
+        sim->sim.simulate_batch(reinterpret_cast<const TraceAccess *>(accesses), count);
+        sim->fed += count;
+    }
+    catch (const std::bad_alloc &)
+    {
+        return SIMCACHE_ERR_MEMORY;
+    }
+    catch (...)
+    {
+        return SIMCACHE_ERR_INTERNAL;
+    }
+    return SIMCACHE_OK;
+}
+
+simcache_status simcache_get_stats(const simcache_t *sim, simcache_stats *out)
+{
+    if (!sim || !out)
+    {
+        return SIMCACHE_ERR_ARGUMENT;
+    }
+
+    const Cache &L1 = sim->sim.getL1();
+    const Cache &L2 = sim->sim.getL2();
+    bool L2_enabled = sim->sim.L2_enabled();
+
+    *out = simcache_stats();
+    out->l1_reads = L1.get_reads();
+    out->l1_read_misses = L1.get_read_misses();
+    out->l1_writes = L1.get_writes();
+    out->l1_write_misses = L1.get_write_misses();
+    out->l1_writebacks = L1.get_writebacks();
+    unsigned long long l1_accesses = out->l1_reads + out->l1_writes;
+    out->l1_miss_rate = l1_accesses > 0 ? static_cast<double>(out->l1_read_misses + out->l1_write_misses) / l1_accesses : 0.0;
+
+    if (L2_enabled)
+    {
+        out->l2_reads = L2.get_reads();
+        out->l2_read_misses = L2.get_read_misses();
+        out->l2_writes = L2.get_writes();
+        out->l2_write_misses = L2.get_write_misses();
+        out->l2_writebacks = L2.get_writebacks();
+        // L2 miss rate only counts reads, same as L2_print_statistics
+        out->l2_miss_rate = out->l2_reads > 0 ? static_cast<double>(out->l2_read_misses) / out->l2_reads : 0.0;
+    }
+
+    out->memory_traffic = sim->sim.memory_traffic();
+    return SIMCACHE_OK;
+}
+
+simcache_status simcache_dump_contents(simcache_t *sim, FILE *out)
+{
+    if (!sim || !out)
+    {
+        return SIMCACHE_ERR_ARGUMENT;
+    }
+
+    try
+    {
+        std::ostringstream contents;
+        sim->sim.print_contents(contents);
+        const std::string text = contents.str();
+        if (fwrite(text.data(), 1, text.size(), out) != text.size())
+        {
+            return SIMCACHE_ERR_INTERNAL;
+        }
+    }
+    catch (const std::bad_alloc &)
+    {
+        return SIMCACHE_ERR_MEMORY;
+    }
+    catch (...)
+    {
+        return SIMCACHE_ERR_INTERNAL;
+    }
+    return SIMCACHE_OK;
+}
+
+} // extern "C"
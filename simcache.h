@@ -0,0 +1,120 @@
+#ifndef SIMCACHE_H
+#define SIMCACHE_H
+
+/*
+ * libsimcache C API
+ *
+ * Drives the same L1/L2 simulator as sim_cache from inside another process:
+ * create a hierarchy, feed it accesses that already live in memory, read the
+ * counters back as a struct. Handles are independent, so a host can keep one
+ * trace in memory and sweep many configurations over it.
+ *
+ *   simcache_config cfg = { 16, 1024, 2, 8192, 4, SIMCACHE_LRU, SIMCACHE_NON_INCLUSIVE };
+ *   simcache_t *sim;
+ *   if (simcache_create(&cfg, &sim) == SIMCACHE_OK)
+ *   {
+ *       simcache_feed(sim, trace, trace_len);
+ *       simcache_stats stats;
+ *       simcache_get_stats(sim, &stats);
+ *       simcache_destroy(sim);
+ *   }
+ *
+ * OPTIMAL replacement needs the future: call simcache_prepare_optimal() with the
+ * whole trace before feeding it (in the same order). Feeding more accesses than
+ * were prepared, or preparing again after feeding started, returns SIMCACHE_ERR_STATE.
+ *
+ * Every function returns a simcache_status; no C++ exception escapes the library.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SIMCACHE_API_VERSION 1
+
+typedef enum simcache_status
+{
+    SIMCACHE_OK = 0,
+    SIMCACHE_ERR_ARGUMENT = -1, /* NULL pointer or invalid configuration */
+    SIMCACHE_ERR_STATE = -2,    /* call not valid right now, e.g. OPTIMAL feed before prepare or past the prepared trace */
+    SIMCACHE_ERR_MEMORY = -3,
+    SIMCACHE_ERR_INTERNAL = -4
+} simcache_status;
+
+enum
+{
+    SIMCACHE_LRU = 0,
+    SIMCACHE_FIFO = 1,
+    SIMCACHE_OPTIMAL = 2
+};
+
+enum
+{
+    SIMCACHE_NON_INCLUSIVE = 0,
+    SIMCACHE_INCLUSIVE = 1
+};
+
+/* same meaning as the sim_cache command-line arguments; l2_size = l2_assoc = 0 disables L2 */
+typedef struct simcache_config
+{
+    uint32_t block_size;
+    uint32_t l1_size;
+    uint32_t l1_assoc;
+    uint32_t l2_size;
+    uint32_t l2_assoc;
+    uint32_t replacement_policy;
+    uint32_t inclusion_policy;
+} simcache_config;
+
+/* one memory reference, op is 'r' or 'w'. Arrays of these are read in place, never copied. */
+typedef struct simcache_access
+{
+    char op;
+    long long address;
+} simcache_access;
+
+/* the a. .. m. lines of the sim_cache report */
+typedef struct simcache_stats
+{
+    uint64_t l1_reads;
+    uint64_t l1_read_misses;
+    uint64_t l1_writes;
+    uint64_t l1_write_misses;
+    double l1_miss_rate;
+    uint64_t l1_writebacks;
+    uint64_t l2_reads;
+    uint64_t l2_read_misses;
+    uint64_t l2_writes;
+    uint64_t l2_write_misses;
+    double l2_miss_rate;
+    uint64_t l2_writebacks;
+    uint64_t memory_traffic;
+} simcache_stats;
+
+typedef struct simcache simcache_t;
+
+int simcache_api_version(void);
+
+simcache_status simcache_create(const simcache_config *config, simcache_t **out);
+void simcache_destroy(simcache_t *sim);
+
+/* OPTIMAL only: scan the full trace once to learn next uses (the pre-processing pass of sim_cache); count <= INT_MAX */
+simcache_status simcache_prepare_optimal(simcache_t *sim, const simcache_access *trace, size_t count);
+
+/* simulate count accesses; may be called repeatedly to stream a trace in pieces */
+simcache_status simcache_feed(simcache_t *sim, const simcache_access *accesses, size_t count);
+
+simcache_status simcache_get_stats(const simcache_t *sim, simcache_stats *out);
+
+/* write the "===== L1 contents =====" (and L2) blocks in sim_cache format */
+simcache_status simcache_dump_contents(simcache_t *sim, FILE *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SIMCACHE_H */